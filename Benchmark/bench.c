@@ -0,0 +1,224 @@
+/*
+* Host benchmark harness for the IoT Hub samples - Copyright (c) 2016 - Licensed MIT
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "stub_control.h"
+
+#define MAX_RESULTS 64
+#define MAX_NAME_LENGTH 64
+
+typedef struct
+{
+    char name[MAX_NAME_LENGTH];
+    double value;
+    char unit[16];
+    BENCH_DIRECTION direction;
+    bool is_exact;
+    double baseline;
+    int has_baseline;
+} BENCH_RESULT;
+
+static BENCH_RESULT g_results[MAX_RESULTS];
+static int g_result_count = 0;
+static long long g_slept = 0;
+
+long long bench_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void add_result(const char *name, double value, const char *unit, BENCH_DIRECTION direction, bool is_exact)
+{
+    if (g_result_count == MAX_RESULTS)
+        return;
+
+    BENCH_RESULT *result = &g_results[g_result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    snprintf(result->unit, sizeof(result->unit), "%s", unit);
+    result->value = value;
+    result->direction = direction;
+    result->is_exact = is_exact;
+    result->has_baseline = 0;
+}
+
+void bench_report(const char *name, double value, const char *unit, BENCH_DIRECTION direction)
+{
+    add_result(name, value, unit, direction, false);
+}
+
+void bench_report_exact(const char *name, double value, const char *unit, BENCH_DIRECTION direction)
+{
+    add_result(name, value, unit, direction, true);
+}
+
+int bench_usleep(useconds_t usec)
+{
+    g_slept += usec;
+    stub_clock_advance(usec);
+    return 0;
+}
+
+long long bench_slept_microseconds(void)
+{
+    return g_slept;
+}
+
+static int write_json(const char *file_name, const char *suite_name)
+{
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL)
+        return 0;
+
+    // One result per line; read_baseline depends on it.
+    fprintf(fp, "{\n  \"suite\": \"%s\",\n  \"results\": [\n", suite_name);
+    for (int i = 0; i < g_result_count; i++)
+    {
+        fprintf(fp, "    { \"name\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", \"better\": \"%s\" }%s\n",
+                g_results[i].name, g_results[i].value, g_results[i].unit,
+                g_results[i].direction == BENCH_LOWER_IS_BETTER ? "lower" : "higher",
+                i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    return fclose(fp) == 0;
+}
+
+static int write_csv(const char *file_name, const char *suite_name)
+{
+    FILE *fp = fopen(file_name, "w");
+    if (fp == NULL)
+        return 0;
+
+    fprintf(fp, "suite,name,value,unit,better\n");
+    for (int i = 0; i < g_result_count; i++)
+    {
+        fprintf(fp, "%s,%s,%.6g,%s,%s\n", suite_name, g_results[i].name, g_results[i].value, g_results[i].unit,
+                g_results[i].direction == BENCH_LOWER_IS_BETTER ? "lower" : "higher");
+    }
+    return fclose(fp) == 0;
+}
+
+static int read_baseline(const char *file_name)
+{
+    FILE *fp = fopen(file_name, "r");
+    if (fp == NULL)
+        return 0;
+
+    char line[512];
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        char name[MAX_NAME_LENGTH];
+        double value;
+        const char *entry = strstr(line, "\"name\"");
+        if (entry == NULL || sscanf(entry, "\"name\": \"%63[^\"]\", \"value\": %lf", name, &value) != 2)
+            continue;
+
+        for (int i = 0; i < g_result_count; i++)
+        {
+            if (0 == strcmp(g_results[i].name, name))
+            {
+                g_results[i].baseline = value;
+                g_results[i].has_baseline = 1;
+            }
+        }
+    }
+
+    fclose(fp);
+    return 1;
+}
+
+static void usage(FILE *out, const char *program)
+{
+    fprintf(out, "usage: %s [--output <file.json>] [--csv <file.csv>] [--baseline <file.json>] [--tolerance <fraction>] [--compare-timing]\n", program);
+}
+
+int bench_main(int argc, char *argv[], const char *suite_name, BENCH_SUITE suite)
+{
+    const char *output = NULL;
+    const char *csv = NULL;
+    const char *baseline = NULL;
+    double tolerance = 0.25;
+    bool is_timing_compared = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && 0 == strcmp(argv[i], "--output"))
+            output = argv[++i];
+        else if (i + 1 < argc && 0 == strcmp(argv[i], "--csv"))
+            csv = argv[++i];
+        else if (i + 1 < argc && 0 == strcmp(argv[i], "--baseline"))
+            baseline = argv[++i];
+        else if (i + 1 < argc && 0 == strcmp(argv[i], "--tolerance"))
+            tolerance = atof(argv[++i]);
+        else if (0 == strcmp(argv[i], "--compare-timing"))
+            is_timing_compared = true;
+        else
+        {
+            usage(stderr, argv[0]);
+            return 2;
+        }
+    }
+
+    // The samples log every message; keep that out of the report.
+    fflush(stdout);
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        fprintf(stderr, "ERROR: Failed to redirect the sample output\n");
+        return 2;
+    }
+
+    suite();
+    fflush(stdout);
+
+    if (baseline != NULL && !read_baseline(baseline))
+    {
+        fprintf(stderr, "ERROR: Failed to read baseline %s\n", baseline);
+        return 2;
+    }
+
+    int regressions = 0;
+    fprintf(report, "%-36s %14s %-8s %14s %8s\n", suite_name, "value", "unit", "baseline", "change");
+    for (int i = 0; i < g_result_count; i++)
+    {
+        BENCH_RESULT *result = &g_results[i];
+        fprintf(report, "%-36s %14.6g %-8s", result->name, result->value, result->unit);
+
+        if (!result->has_baseline || result->baseline <= 0)
+        {
+            fprintf(report, " %14s\n", "-");
+            continue;
+        }
+
+        // Positive change means worse, whichever direction is better.
+        double change = result->direction == BENCH_LOWER_IS_BETTER
+                            ? result->value / result->baseline - 1
+                            : result->baseline / result->value - 1;
+        bool is_compared = result->is_exact || is_timing_compared;
+        bool is_regression = is_compared && change > tolerance;
+        regressions += is_regression;
+        fprintf(report, " %14.6g %+7.1f%%%s\n", result->baseline, change * 100,
+                is_regression ? "  REGRESSION" : is_compared ? "" : "  (timing, not compared)");
+    }
+
+    if ((output != NULL && !write_json(output, suite_name)) || (csv != NULL && !write_csv(csv, suite_name)))
+    {
+        fprintf(stderr, "ERROR: Failed to write the results\n");
+        return 2;
+    }
+
+    if (regressions > 0)
+        fprintf(report, "%d result(s) regressed by more than %.0f%%\n", regressions, tolerance * 100);
+    fclose(report);
+    return regressions > 0 ? 1 : 0;
+}
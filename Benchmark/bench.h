@@ -0,0 +1,39 @@
+/*
+* Host benchmark harness for the IoT Hub samples - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <unistd.h>
+
+typedef enum
+{
+    BENCH_LOWER_IS_BETTER,
+    BENCH_HIGHER_IS_BETTER
+} BENCH_DIRECTION;
+
+typedef void (*BENCH_SUITE)(void);
+
+// CLOCK_MONOTONIC time in nanoseconds.
+long long bench_now(void);
+
+// A timing result depends on the machine, so it is only compared against a
+// baseline with --compare-timing.
+void bench_report(const char *name, double value, const char *unit, BENCH_DIRECTION direction);
+
+// A result that does not depend on the machine, such as a compression
+// ratio, is always compared against the baseline.
+void bench_report_exact(const char *name, double value, const char *unit, BENCH_DIRECTION direction);
+
+// Replaces usleep in the sample code under test: the sleep is recorded and
+// moves the stub clock on, but is not taken, so a 0.1 second LED blink does
+// not dominate every measurement.
+int bench_usleep(useconds_t usec);
+long long bench_slept_microseconds(void);
+
+// Runs the suite and writes its results; see README.md for the options.
+// Returns non-zero when a result regressed against the baseline.
+int bench_main(int argc, char *argv[], const char *suite_name, BENCH_SUITE suite);
+
+#endif /* BENCH_H */
@@ -0,0 +1,318 @@
+/*
+* Host benchmarks for the Lesson 3 device-to-cloud sample - Copyright (c) 2016 - Licensed MIT
+*/
+
+#include "bench.h"
+#include "stub_control.h"
+
+// The sample is compiled into the benchmark so that its static functions can
+// be measured as they are; its main() is renamed out of the way.
+#define main lesson3_main
+#define usleep bench_usleep
+#include "../Lesson3/app/main.c"
+#undef usleep
+#undef main
+
+#define ITERATIONS 20000
+
+// Gateway load: readings from GATEWAY_SENSORS sensors arrive over UDP faster
+// than the gateway forwards them, and the stub broker confirms each message
+// BROKER_LATENCY_US after it was handed over.
+#define GATEWAY_SENSORS 32
+#define GATEWAY_DATAGRAMS_PER_ROUND 64
+#define GATEWAY_ROUND_US 10000  // run_gateway's usleep between rounds
+#define GATEWAY_RUN_NS 1000000000LL
+#define BROKER_LATENCY_US 20000
+
+// End-to-end latencies assume a 100 kbit/s uplink, such as a weak cellular
+// connection, where the payload size shows in the time to confirmation.
+#define LINK_NS_PER_BYTE 80000
+#define END_TO_END_TRIALS 100
+#define CONFIRM_POLL_US 100
+
+static IOTHUB_CLIENT_LL_HANDLE g_client;
+static size_t g_confirmed_readings = 0;
+static long long g_confirmed_time = 0;
+
+// Build the telemetry message and hand it over to the client.
+static void bench_message_construction(void)
+{
+    long long elapsed = 0;
+
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        long long start = bench_now();
+        send_message_and_blink(g_client, "edison-bench");
+        elapsed += bench_now() - start;
+
+        IoTHubClient_LL_DoWork(g_client);
+    }
+
+    bench_report("message_construction", (double)elapsed / ITERATIONS, "ns/op", BENCH_LOWER_IS_BETTER);
+}
+
+// Send, confirm through DoWork and blink in send_callback, one message at a time.
+static void bench_send_confirm(void)
+{
+    stub_iothub_reset_counters();
+    long long start = bench_now();
+
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        send_message_and_blink(g_client, "edison-bench");
+        IoTHubClient_LL_DoWork(g_client);
+    }
+
+    long long elapsed = bench_now() - start;
+    bench_report("send_confirm_throughput", stub_iothub_messages_confirmed() * 1e9 / elapsed, "msg/s", BENCH_HIGHER_IS_BETTER);
+}
+
+// The body of main's loop, without its sleep, while a message is in flight.
+static void bench_dowork_loop(void)
+{
+    g_is_message_pending = true;
+    long long start = bench_now();
+
+    for (int i = 0; i < ITERATIONS * 10; i++)
+    {
+        if ((g_last_message_sent_time + 2 <= get_time_in_seconds()) && !g_is_message_pending)
+            send_message_and_blink(g_client, "edison-bench");
+
+        IoTHubClient_LL_DoWork(g_client);
+    }
+
+    long long elapsed = bench_now() - start;
+    g_is_message_pending = false;
+    bench_report("dowork_loop_overhead", (double)elapsed / (ITERATIONS * 10), "ns/iter", BENCH_LOWER_IS_BETTER);
+}
+
+// Count the readings in a confirmed gateway batch, inflating it if needed.
+static void count_confirmed_readings(IOTHUB_MESSAGE_HANDLE message)
+{
+    static unsigned char inflated[GATEWAY_BATCH_SIZE + 512];
+    const unsigned char *bytes = NULL;
+    size_t size = 0;
+
+    if (IOTHUB_MESSAGE_OK != IoTHubMessage_GetByteArray(message, &bytes, &size))
+        return;
+
+    const char *encoding = Map_GetValueFromKey(IoTHubMessage_Properties(message), "contentEncoding");
+    if (encoding != NULL && 0 == strcmp(encoding, "deflate"))
+    {
+        uLongf inflated_size = sizeof(inflated) - 1;
+        if (uncompress(inflated, &inflated_size, bytes, size) != Z_OK)
+            return;
+        bytes = inflated;
+        size = inflated_size;
+    }
+
+    const char *key = "\"deviceId\"";
+    size_t key_length = strlen(key);
+    for (size_t i = 0; i + key_length <= size; i++)
+    {
+        if (0 == memcmp(bytes + i, key, key_length))
+            g_confirmed_readings++;
+    }
+}
+
+static void bench_gateway(int pool_size)
+{
+    char connection_string[128];
+    for (int i = 0; i < pool_size; i++)
+    {
+        GATEWAY_CONNECTION *connection = &g_pool[i];
+        snprintf(connection->device_id, sizeof(connection->device_id), "edison-gateway-%d", i);
+        snprintf(connection_string, sizeof(connection_string), "HostName=bench;DeviceId=%s;SharedAccessKey=bench", connection->device_id);
+        connection->handle = create_iot_hub_client(connection_string, connection->device_id);
+    }
+    g_pool_size = pool_size;
+
+    int gateway_sock = open_gateway_socket(0);
+    int load_sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+    getsockname(gateway_sock, (struct sockaddr *)&address, &address_length);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    g_confirmed_readings = 0;
+    int next_sensor = 0;
+    long long start = bench_now();
+    long long elapsed;
+
+    while ((elapsed = bench_now() - start) < GATEWAY_RUN_NS)
+    {
+        char datagram[64];
+        for (int i = 0; i < GATEWAY_DATAGRAMS_PER_ROUND; i++)
+        {
+            int length = snprintf(datagram, sizeof(datagram), "sensor-%02d %d.%d", next_sensor, 20 + i % 10, i % 7);
+            sendto(load_sock, datagram, length, 0, (struct sockaddr *)&address, sizeof(address));
+            next_sensor = (next_sensor + 1) % GATEWAY_SENSORS;
+        }
+        poll_gateway(gateway_sock);
+        usleep(GATEWAY_ROUND_US);
+    }
+
+    // Readings batched during the run count once the broker confirms them;
+    // only the stub clock has to move for that.
+    bool is_sending = true;
+    while (is_sending)
+    {
+        send_due_batches(true);
+        stub_clock_advance(BROKER_LATENCY_US);
+
+        is_sending = false;
+        for (int i = 0; i < pool_size; i++)
+        {
+            IoTHubClient_LL_DoWork(g_pool[i].handle);
+            is_sending = is_sending || g_pool[i].pending > 0 || g_pool[i].batch_count > 0;
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "gateway_throughput_pool%d", pool_size);
+    bench_report(name, g_confirmed_readings * 1e9 / elapsed, "reading/s", BENCH_HIGHER_IS_BETTER);
+
+    close(load_sock);
+    close(gateway_sock);
+    for (int i = 0; i < pool_size; i++)
+    {
+        IoTHubClient_LL_Destroy(g_pool[i].handle);
+    }
+    memset(g_pool, 0, sizeof(g_pool));
+    g_pool_size = 0;
+    g_sensor_count = 0;
+    g_first_sensor = 0;
+}
+
+// A gateway batch of the given number of readings, in the format send_batch
+// uses; 0 fills the batch as far as batch_reading would.
+static void build_batch_payload(char *buffer, size_t size, int readings)
+{
+    int length = snprintf(buffer, size, "{\"gatewayId\":\"edison-gateway-0\",\"readings\":[");
+    for (int i = 0; readings == 0 ? length < GATEWAY_BATCH_SIZE - MAX_BATCH_ENTRY_LENGTH : i < readings; i++)
+    {
+        length += snprintf(buffer + length, size - length, "%s{\"deviceId\":\"sensor-%02d\",\"reading\":%.*g}",
+                           i == 0 ? "" : ",", i % GATEWAY_SENSORS, DBL_DIG, 15 + (i * 37 % 150) / 10.0);
+    }
+    snprintf(buffer + length, size - length, "]}");
+}
+
+static void record_confirmed_time(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *userContextCallback)
+{
+    g_confirmed_time = stub_clock_now();
+}
+
+// Average time from building a message to its confirmation, in milliseconds
+// on the stub clock, with DoWork polled every CONFIRM_POLL_US. Without
+// compression the payload is sent as it is.
+static double measure_end_to_end(const char *payload, bool is_compressed)
+{
+    long long total = 0;
+
+    for (int i = 0; i < END_TO_END_TRIALS; i++)
+    {
+        g_confirmed_time = 0;
+        long long start = stub_clock_now();
+
+        IOTHUB_MESSAGE_HANDLE message = is_compressed
+            ? create_message(payload)
+            : IoTHubMessage_CreateFromByteArray((const unsigned char *)payload, strlen(payload));
+        IoTHubClient_LL_SendEventAsync(g_client, message, record_confirmed_time, NULL);
+        IoTHubMessage_Destroy(message);
+
+        while (g_confirmed_time == 0)
+        {
+            stub_clock_advance(CONFIRM_POLL_US);
+            IoTHubClient_LL_DoWork(g_client);
+        }
+        total += g_confirmed_time - start;
+    }
+
+    return total / 1e6 / END_TO_END_TRIALS;
+}
+
+// Bytes on the wire, counting the property that marks deflated payloads,
+// against the payload, the time create_message takes for it, and the time
+// to confirmation with and without compression.
+static void bench_compression(const char *name, const char *payload)
+{
+    const int iterations = ITERATIONS / 10;
+    IOTHUB_MESSAGE_HANDLE message = create_message(payload);
+    const unsigned char *bytes = NULL;
+    size_t size = 0;
+    IoTHubMessage_GetByteArray(message, &bytes, &size);
+    if (Map_GetValueFromKey(IoTHubMessage_Properties(message), "contentEncoding") != NULL)
+        size += CONTENT_ENCODING_OVERHEAD;
+    IoTHubMessage_Destroy(message);
+
+    long long start = bench_now();
+    for (int i = 0; i < iterations; i++)
+    {
+        IoTHubMessage_Destroy(create_message(payload));
+    }
+    long long elapsed = bench_now() - start;
+
+    char result_name[64];
+    snprintf(result_name, sizeof(result_name), "compression_ratio_%s", name);
+    bench_report_exact(result_name, (double)size / strlen(payload), "ratio", BENCH_LOWER_IS_BETTER);
+    snprintf(result_name, sizeof(result_name), "create_message_%s", name);
+    bench_report(result_name, (double)elapsed / iterations, "ns/op", BENCH_LOWER_IS_BETTER);
+    snprintf(result_name, sizeof(result_name), "end_to_end_%s", name);
+    bench_report(result_name, measure_end_to_end(payload, true), "ms", BENCH_LOWER_IS_BETTER);
+    snprintf(result_name, sizeof(result_name), "end_to_end_%s_uncompressed", name);
+    bench_report(result_name, measure_end_to_end(payload, false), "ms", BENCH_LOWER_IS_BETTER);
+}
+
+static void bench_compression_corpus(void)
+{
+    static char payload[GATEWAY_BATCH_SIZE + 512];
+    stub_iothub_set_link_cost(LINK_NS_PER_BYTE);
+    stub_iothub_set_confirm_latency(BROKER_LATENCY_US);
+
+    snprintf(payload, sizeof(payload), "{\"deviceId\":\"edison-bench\",\"messageId\":%d}", MAX_BLINK_TIMES);
+    bench_compression("telemetry", payload);
+
+    const int batch_readings[] = { 1, 2, 4, 16, 0 };
+    for (int i = 0; i < (int)(sizeof(batch_readings) / sizeof(batch_readings[0])); i++)
+    {
+        char name[32];
+        if (batch_readings[i] == 0)
+            snprintf(name, sizeof(name), "batch_full");
+        else
+            snprintf(name, sizeof(name), "batch%d", batch_readings[i]);
+
+        build_batch_payload(payload, sizeof(payload), batch_readings[i]);
+        bench_compression(name, payload);
+    }
+
+    stub_iothub_set_confirm_latency(0);
+    stub_iothub_set_link_cost(0);
+}
+
+static void run_suite(void)
+{
+    g_context = mraa_gpio_init(LED_PIN);
+    g_client = create_iot_hub_client("HostName=bench;DeviceId=edison-bench;SharedAccessKey=bench", "edison-bench");
+
+    bench_message_construction();
+    bench_send_confirm();
+    bench_dowork_loop();
+    bench_compression_corpus();
+
+    IoTHubClient_LL_Destroy(g_client);
+    mraa_gpio_close(g_context);
+
+    stub_iothub_set_confirm_hook(count_confirmed_readings);
+    stub_iothub_set_confirm_latency(BROKER_LATENCY_US);
+    for (int pool_size = 1; pool_size <= MAX_POOL_SIZE; pool_size *= 2)
+    {
+        bench_gateway(pool_size);
+    }
+    stub_iothub_set_confirm_latency(0);
+    stub_iothub_set_confirm_hook(NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    return bench_main(argc, argv, "lesson3", run_suite);
+}
@@ -0,0 +1,195 @@
+/*
+* Host benchmarks for the Lesson 4 cloud-to-device sample - Copyright (c) 2016 - Licensed MIT
+*/
+
+#include "bench.h"
+#include "stub_control.h"
+
+// The sample is compiled into the benchmark so that its static functions can
+// be measured as they are; its main() is renamed out of the way.
+#define main lesson4_main
+#define usleep bench_usleep
+#include "../Lesson4/app/main.c"
+#undef usleep
+#undef main
+
+#define ITERATIONS 20000
+#define REACTION_TRIALS 2000
+#define LOOP_WAIT_US 100000  // main's usleep between passes
+// Assumed time for a reading to reach the IoT hub and a command to come back
+// to the device over Wi-Fi; the stub delivers cloud-to-device messages this late.
+#define CLOUD_ROUND_TRIP_US 250000
+
+static IOTHUB_CLIENT_LL_HANDLE g_client;
+
+// Push a command through the same path as a cloud-to-device message.
+static void deliver_command(const char *payload)
+{
+    stub_iothub_deliver_message(g_client, payload);
+    IoTHubClient_LL_DoWork(g_client);
+}
+
+// One pass of main's loop, without its sleep.
+static void run_loop_once(void)
+{
+    evaluate_rules();
+    IoTHubClient_LL_DoWork(g_client);
+}
+
+// Wait as main does between passes. The wait is not taken but moves the stub
+// clock on, so it counts in the latencies below.
+static void wait_loop(long long microseconds)
+{
+    bench_usleep((useconds_t)microseconds);
+}
+
+// Run one pass with the sample below the threshold, then move the sample
+// above it part way through the following wait; the trials spread that point
+// evenly over the wait. Returns the stub clock time of the crossing.
+static long long cross_threshold(int trial)
+{
+    long long phase = (long long)LOOP_WAIT_US * trial / REACTION_TRIALS;
+
+    stub_mraa_set_aio_value(0, 100);
+    run_loop_once();
+    wait_loop(phase);
+
+    stub_mraa_set_aio_value(0, 1000);
+    long long crossed = stub_clock_now();
+    wait_loop(LOOP_WAIT_US - phase);
+    return crossed;
+}
+
+// Decode a "blink" command and dispatch it to blink_led.
+static void bench_c2d_decode_dispatch(void)
+{
+    const char *payload = "{\"command\":\"blink\",\"messageId\":1}";
+    IOTHUB_MESSAGE_HANDLE message = IoTHubMessage_CreateFromByteArray((const unsigned char *)payload, strlen(payload));
+    long long start = bench_now();
+
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        receive_message_callback(message, NULL);
+    }
+
+    long long elapsed = bench_now() - start;
+    IoTHubMessage_Destroy(message);
+    bench_report("c2d_decode_dispatch", (double)elapsed / ITERATIONS, "ns/op", BENCH_LOWER_IS_BETTER);
+}
+
+static void bench_gpio_toggle(void)
+{
+    unsigned long writes = stub_mraa_gpio_writes();
+    long long start = bench_now();
+
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        blink_led();
+    }
+
+    long long elapsed = bench_now() - start;
+    bench_report("gpio_toggle_rate", (stub_mraa_gpio_writes() - writes) * 1e9 / elapsed, "writes/s", BENCH_HIGHER_IS_BETTER);
+}
+
+// A full table of rules that do not fire, sampled once per pass.
+static void bench_rule_evaluation(void)
+{
+    char payload[128];
+    for (int i = 0; i < MAX_RULES; i++)
+    {
+        snprintf(payload, sizeof(payload), "{\"command\":\"rule\",\"pin\":%d,\"above\":512,\"window\":5}", i);
+        deliver_command(payload);
+        stub_mraa_set_aio_value(i, 100);
+    }
+
+    long long start = bench_now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        evaluate_rules();
+    }
+    long long elapsed = bench_now() - start;
+
+    bench_report("rule_evaluation", (double)elapsed / ((long long)ITERATIONS * g_rule_count), "ns/rule", BENCH_LOWER_IS_BETTER);
+    deliver_command("{\"command\":\"clear-rules\"}");
+}
+
+// From the sample crossing the threshold to the LED going on, when a rule reacts on the device.
+static void bench_rule_reaction(void)
+{
+    long long total = 0;
+    deliver_command("{\"command\":\"rule\",\"pin\":0,\"above\":512}");
+
+    for (int i = 0; i < REACTION_TRIALS; i++)
+    {
+        long long crossed = cross_threshold(i);
+        run_loop_once();
+        total += stub_mraa_last_gpio_high_time() - crossed;
+    }
+
+    bench_report("rule_reaction_latency", total / 1e6 / REACTION_TRIALS, "ms", BENCH_LOWER_IS_BETTER);
+    deliver_command("{\"command\":\"clear-rules\"}");
+}
+
+// From the sample crossing the threshold to the LED going on, when the cloud
+// decides: the next pass reads the sample and reports it, and the "blink"
+// command comes back a cloud round trip later, to be picked up by a later pass.
+static void bench_c2d_reaction(void)
+{
+    long long total = 0;
+    stub_iothub_set_delivery_latency(CLOUD_ROUND_TRIP_US);
+
+    for (int i = 0; i < REACTION_TRIALS; i++)
+    {
+        long long crossed = cross_threshold(i);
+        run_loop_once();
+        stub_iothub_deliver_message(g_client, "{\"command\":\"blink\"}");
+
+        while (stub_mraa_last_gpio_high_time() < crossed)
+        {
+            wait_loop(LOOP_WAIT_US);
+            run_loop_once();
+        }
+        total += stub_mraa_last_gpio_high_time() - crossed;
+    }
+
+    stub_iothub_set_delivery_latency(0);
+    bench_report("c2d_reaction_latency", total / 1e6 / REACTION_TRIALS, "ms", BENCH_LOWER_IS_BETTER);
+}
+
+// Run the sample's own main loop, without its sleep, until a scheduled "stop" arrives.
+static void bench_dowork_loop(void)
+{
+    char connection_string[] = "HostName=bench;DeviceId=edison-bench;SharedAccessKey=bench";
+    char *argv[] = { "lesson4", connection_string, NULL };
+    const unsigned long iterations = ITERATIONS * 10;
+
+    stub_iothub_schedule_message(iterations, "{\"command\":\"stop\"}");
+    is_last_message_received = false;
+    long long start = bench_now();
+
+    lesson4_main(2, argv);
+
+    long long elapsed = bench_now() - start;
+    bench_report("dowork_loop_overhead", (double)elapsed / iterations, "ns/iter", BENCH_LOWER_IS_BETTER);
+}
+
+static void run_suite(void)
+{
+    g_context = mraa_gpio_init(LED_PIN);
+    g_client = IoTHubClient_LL_CreateFromConnectionString("HostName=bench;DeviceId=edison-bench;SharedAccessKey=bench", MQTT_Protocol);
+    IoTHubClient_LL_SetMessageCallback(g_client, receive_message_callback, NULL);
+
+    bench_c2d_decode_dispatch();
+    bench_gpio_toggle();
+    bench_rule_evaluation();
+    bench_rule_reaction();
+    bench_c2d_reaction();
+    bench_dowork_loop();
+
+    IoTHubClient_LL_Destroy(g_client);
+}
+
+int main(int argc, char *argv[])
+{
+    return bench_main(argc, argv, "lesson4", run_suite);
+}
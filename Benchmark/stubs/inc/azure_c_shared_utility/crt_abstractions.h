@@ -0,0 +1,11 @@
+/*
+* Stub of the Azure IoT C SDK CRT abstractions, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef CRT_ABSTRACTIONS_H
+#define CRT_ABSTRACTIONS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#endif /* CRT_ABSTRACTIONS_H */
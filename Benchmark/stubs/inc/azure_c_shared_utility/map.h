@@ -0,0 +1,22 @@
+/*
+* Stub of the Azure IoT C SDK map API, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef MAP_H
+#define MAP_H
+
+typedef struct MAP_HANDLE_DATA_TAG *MAP_HANDLE;
+
+typedef enum
+{
+    MAP_OK,
+    MAP_ERROR,
+    MAP_INVALIDARG,
+    MAP_KEYEXISTS,
+    MAP_KEYNOTFOUND
+} MAP_RESULT;
+
+MAP_RESULT Map_AddOrUpdate(MAP_HANDLE handle, const char *key, const char *value);
+const char *Map_GetValueFromKey(MAP_HANDLE handle, const char *key);
+
+#endif /* MAP_H */
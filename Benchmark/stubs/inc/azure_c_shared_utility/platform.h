@@ -0,0 +1,11 @@
+/*
+* Stub of the Azure IoT C SDK platform API, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+int platform_init(void);
+void platform_deinit(void);
+
+#endif /* PLATFORM_H */
@@ -0,0 +1,10 @@
+/*
+* Stub of the Azure IoT C SDK thread API, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef THREADAPI_H
+#define THREADAPI_H
+
+#include <unistd.h>
+
+#endif /* THREADAPI_H */
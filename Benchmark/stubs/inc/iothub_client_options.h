@@ -0,0 +1,11 @@
+/*
+* Stub of the Azure IoT C SDK client options, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef IOTHUB_CLIENT_OPTIONS_H
+#define IOTHUB_CLIENT_OPTIONS_H
+
+#define OPTION_X509_CERT "x509certificate"
+#define OPTION_X509_PRIVATE_KEY "x509privatekey"
+
+#endif /* IOTHUB_CLIENT_OPTIONS_H */
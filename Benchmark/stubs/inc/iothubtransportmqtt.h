@@ -0,0 +1,12 @@
+/*
+* Stub of the Azure IoT C SDK MQTT transport, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef IOTHUBTRANSPORTMQTT_H
+#define IOTHUBTRANSPORTMQTT_H
+
+#include "iothub_client.h"
+
+const TRANSPORT_PROVIDER *MQTT_Protocol(void);
+
+#endif /* IOTHUBTRANSPORTMQTT_H */
@@ -0,0 +1,21 @@
+/*
+* Stub of the Azure IoT C SDK serializer JSON decoder, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef JSONDECODER_H
+#define JSONDECODER_H
+
+#include "multitree.h"
+
+typedef enum
+{
+    JSON_DECODER_OK,
+    JSON_DECODER_INVALID_ARG,
+    JSON_DECODER_PARSE_ERROR,
+    JSON_DECODER_MULTITREE_FAILED,
+    JSON_DECODER_ERROR
+} JSON_DECODER_RESULT;
+
+JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char *json, MULTITREE_HANDLE *multiTreeHandle);
+
+#endif /* JSONDECODER_H */
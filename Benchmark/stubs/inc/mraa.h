@@ -0,0 +1,36 @@
+/*
+* Stub of the libmraa API used by the samples, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef MRAA_H
+#define MRAA_H
+
+#include <stdbool.h>
+#include <unistd.h>
+
+typedef struct _gpio *mraa_gpio_context;
+typedef struct _aio *mraa_aio_context;
+
+typedef enum
+{
+    MRAA_SUCCESS = 0,
+    MRAA_ERROR_INVALID_HANDLE = 6,
+    MRAA_ERROR_UNSPECIFIED = 99
+} mraa_result_t;
+
+typedef enum
+{
+    MRAA_GPIO_OUT = 0,
+    MRAA_GPIO_IN = 1
+} mraa_gpio_dir_t;
+
+mraa_gpio_context mraa_gpio_init(int pin);
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir);
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value);
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev);
+
+mraa_aio_context mraa_aio_init(unsigned int pin);
+int mraa_aio_read(mraa_aio_context dev);
+mraa_result_t mraa_aio_close(mraa_aio_context dev);
+
+#endif /* MRAA_H */
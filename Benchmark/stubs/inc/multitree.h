@@ -0,0 +1,25 @@
+/*
+* Stub of the Azure IoT C SDK serializer multitree API, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef MULTITREE_H
+#define MULTITREE_H
+
+typedef struct MULTITREE_HANDLE_DATA_TAG *MULTITREE_HANDLE;
+
+typedef enum
+{
+    MULTITREE_OK,
+    MULTITREE_INVALID_ARG,
+    MULTITREE_ALREADY_HAS_A_VALUE,
+    MULTITREE_EMPTY_CHILD_NAME,
+    MULTITREE_EMPTY_VALUE,
+    MULTITREE_OUT_OF_RANGE_INDEX,
+    MULTITREE_ERROR,
+    MULTITREE_CHILD_NOT_FOUND
+} MULTITREE_RESULT;
+
+MULTITREE_RESULT MultiTree_GetLeafValue(MULTITREE_HANDLE treeHandle, const char *leafPath, const void **destination);
+void MultiTree_Destroy(MULTITREE_HANDLE treeHandle);
+
+#endif /* MULTITREE_H */
@@ -0,0 +1,22 @@
+/*
+* Clock shared by the stubs and the host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#include <time.h>
+
+#include "stub_control.h"
+
+static long long g_advanced = 0;
+
+long long stub_clock_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000000000 + now.tv_nsec + g_advanced;
+}
+
+void stub_clock_advance(long long microseconds)
+{
+    g_advanced += microseconds * 1000;
+}
@@ -0,0 +1,55 @@
+/*
+* Controls for the stub mraa and IoT Hub client used by the host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#ifndef STUB_CONTROL_H
+#define STUB_CONTROL_H
+
+#include <stddef.h>
+#include "iothub_client.h"
+
+// CLOCK_MONOTONIC time in nanoseconds, plus every wait passed to
+// stub_clock_advance. The stubs time confirmations, deliveries and GPIO
+// writes with it, so a wait that is recorded but not taken still counts.
+long long stub_clock_now(void);
+void stub_clock_advance(long long microseconds);
+
+// Messages handed to IoTHubClient_LL_SendEventAsync are confirmed by the
+// first IoTHubClient_LL_DoWork call made at least this long after they were
+// transmitted.
+void stub_iothub_set_confirm_latency(long long microseconds);
+
+// Time each client's link takes to transmit a byte of payload or properties.
+// A client transmits one message at a time, in the order they were sent.
+void stub_iothub_set_link_cost(long long nanoseconds_per_byte);
+
+// Called with every message as it is confirmed, before the sender's callback.
+typedef void (*STUB_CONFIRM_HOOK)(IOTHUB_MESSAGE_HANDLE message);
+void stub_iothub_set_confirm_hook(STUB_CONFIRM_HOOK hook);
+
+// Cloud-to-device messages are delivered by the first IoTHubClient_LL_DoWork
+// call made at least this long after they were queued.
+void stub_iothub_set_delivery_latency(long long microseconds);
+
+// Queue a cloud-to-device message for delivery by IoTHubClient_LL_DoWork.
+void stub_iothub_deliver_message(IOTHUB_CLIENT_LL_HANDLE handle, const char *payload);
+
+// Queue a cloud-to-device message for whichever client makes the given
+// number of further IoTHubClient_LL_DoWork calls first, so a message can be
+// scheduled for a client that the code under test has yet to create.
+void stub_iothub_schedule_message(unsigned long dowork_calls, const char *payload);
+
+// Totals across all clients since the last stub_iothub_reset_counters.
+void stub_iothub_reset_counters(void);
+size_t stub_iothub_messages_confirmed(void);
+size_t stub_iothub_bytes_sent(void);
+
+// Value returned by mraa_aio_read for the pin.
+void stub_mraa_set_aio_value(unsigned int pin, int value);
+
+unsigned long stub_mraa_gpio_writes(void);
+
+// stub_clock_now time at which a pin was last written high.
+long long stub_mraa_last_gpio_high_time(void);
+
+#endif /* STUB_CONTROL_H */
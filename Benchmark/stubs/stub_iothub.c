@@ -0,0 +1,399 @@
+/*
+* Stub of the Azure IoT C SDK lower layer client, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*
+* The client stands in for the MQTT broker: sent messages are kept in memory
+* and confirmed by a later DoWork call, and cloud-to-device messages queued by
+* the benchmark are delivered by a later DoWork call.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "azure_c_shared_utility/platform.h"
+#include "iothub_client.h"
+#include "iothub_message.h"
+#include "iothubtransportmqtt.h"
+
+#include "stub_control.h"
+
+#define MAX_PROPERTIES 8
+
+struct MAP_HANDLE_DATA_TAG
+{
+    char *keys[MAX_PROPERTIES];
+    char *values[MAX_PROPERTIES];
+    int count;
+};
+
+struct IOTHUB_MESSAGE_HANDLE_DATA_TAG
+{
+    unsigned char *bytes;
+    size_t size;
+    struct MAP_HANDLE_DATA_TAG properties;
+};
+
+typedef struct OUTGOING_TAG
+{
+    IOTHUB_MESSAGE_HANDLE message;
+    IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK callback;
+    void *context;
+    long long confirm_time;
+    struct OUTGOING_TAG *next;
+} OUTGOING;
+
+typedef struct INCOMING_TAG
+{
+    IOTHUB_MESSAGE_HANDLE message;
+    long long queued_time;
+    struct INCOMING_TAG *next;
+} INCOMING;
+
+struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG
+{
+    OUTGOING *outgoing_head;
+    OUTGOING *outgoing_tail;
+    INCOMING *incoming_head;
+    INCOMING *incoming_tail;
+    IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC message_callback;
+    void *message_context;
+    long long link_free_time;
+};
+
+struct TRANSPORT_PROVIDER_TAG
+{
+    int unused;
+};
+
+static const TRANSPORT_PROVIDER g_mqtt_provider = { 0 };
+static long long g_confirm_latency = 0;
+static long long g_delivery_latency = 0;
+static long long g_link_cost = 0;
+static size_t g_messages_confirmed = 0;
+static size_t g_bytes_sent = 0;
+static STUB_CONFIRM_HOOK g_confirm_hook = NULL;
+static char *g_scheduled_payload = NULL;
+static unsigned long g_scheduled_dowork_calls = 0;
+
+static size_t get_wire_size(IOTHUB_MESSAGE_HANDLE message)
+{
+    size_t size = message->size;
+    for (int i = 0; i < message->properties.count; i++)
+    {
+        size += strlen(message->properties.keys[i]) + strlen(message->properties.values[i]);
+    }
+    return size;
+}
+
+int platform_init(void)
+{
+    return 0;
+}
+
+void platform_deinit(void)
+{
+}
+
+const TRANSPORT_PROVIDER *MQTT_Protocol(void)
+{
+    return &g_mqtt_provider;
+}
+
+MAP_RESULT Map_AddOrUpdate(MAP_HANDLE handle, const char *key, const char *value)
+{
+    if (handle == NULL || key == NULL || value == NULL)
+        return MAP_INVALIDARG;
+
+    for (int i = 0; i < handle->count; i++)
+    {
+        if (0 == strcmp(handle->keys[i], key))
+        {
+            char *copy = strdup(value);
+            if (copy == NULL)
+                return MAP_ERROR;
+            free(handle->values[i]);
+            handle->values[i] = copy;
+            return MAP_OK;
+        }
+    }
+
+    if (handle->count == MAX_PROPERTIES)
+        return MAP_ERROR;
+
+    handle->keys[handle->count] = strdup(key);
+    handle->values[handle->count] = strdup(value);
+    if (handle->keys[handle->count] == NULL || handle->values[handle->count] == NULL)
+    {
+        free(handle->keys[handle->count]);
+        free(handle->values[handle->count]);
+        return MAP_ERROR;
+    }
+    handle->count++;
+    return MAP_OK;
+}
+
+const char *Map_GetValueFromKey(MAP_HANDLE handle, const char *key)
+{
+    for (int i = 0; handle != NULL && i < handle->count; i++)
+    {
+        if (0 == strcmp(handle->keys[i], key))
+            return handle->values[i];
+    }
+    return NULL;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_CreateFromByteArray(const unsigned char *byteArray, size_t size)
+{
+    IOTHUB_MESSAGE_HANDLE message = calloc(1, sizeof(struct IOTHUB_MESSAGE_HANDLE_DATA_TAG));
+    if (message == NULL)
+        return NULL;
+
+    message->bytes = malloc(size == 0 ? 1 : size);
+    if (message->bytes == NULL)
+    {
+        free(message);
+        return NULL;
+    }
+    memcpy(message->bytes, byteArray, size);
+    message->size = size;
+    return message;
+}
+
+IOTHUB_MESSAGE_HANDLE IoTHubMessage_Clone(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    IOTHUB_MESSAGE_HANDLE clone = IoTHubMessage_CreateFromByteArray(iotHubMessageHandle->bytes, iotHubMessageHandle->size);
+    for (int i = 0; clone != NULL && i < iotHubMessageHandle->properties.count; i++)
+    {
+        if (MAP_OK != Map_AddOrUpdate(&clone->properties, iotHubMessageHandle->properties.keys[i], iotHubMessageHandle->properties.values[i]))
+        {
+            IoTHubMessage_Destroy(clone);
+            clone = NULL;
+        }
+    }
+    return clone;
+}
+
+IOTHUB_MESSAGE_RESULT IoTHubMessage_GetByteArray(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle, const unsigned char **buffer, size_t *size)
+{
+    if (iotHubMessageHandle == NULL || buffer == NULL || size == NULL)
+        return IOTHUB_MESSAGE_INVALID_ARG;
+
+    *buffer = iotHubMessageHandle->bytes;
+    *size = iotHubMessageHandle->size;
+    return IOTHUB_MESSAGE_OK;
+}
+
+MAP_HANDLE IoTHubMessage_Properties(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    return iotHubMessageHandle == NULL ? NULL : &iotHubMessageHandle->properties;
+}
+
+void IoTHubMessage_Destroy(IOTHUB_MESSAGE_HANDLE iotHubMessageHandle)
+{
+    if (iotHubMessageHandle == NULL)
+        return;
+
+    for (int i = 0; i < iotHubMessageHandle->properties.count; i++)
+    {
+        free(iotHubMessageHandle->properties.keys[i]);
+        free(iotHubMessageHandle->properties.values[i]);
+    }
+    free(iotHubMessageHandle->bytes);
+    free(iotHubMessageHandle);
+}
+
+IOTHUB_CLIENT_LL_HANDLE IoTHubClient_LL_CreateFromConnectionString(const char *connectionString, IOTHUB_CLIENT_TRANSPORT_PROVIDER protocol)
+{
+    if (connectionString == NULL || protocol == NULL)
+        return NULL;
+
+    return calloc(1, sizeof(struct IOTHUB_CLIENT_LL_HANDLE_DATA_TAG));
+}
+
+void IoTHubClient_LL_Destroy(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    if (iotHubClientHandle == NULL)
+        return;
+
+    while (iotHubClientHandle->outgoing_head != NULL)
+    {
+        OUTGOING *outgoing = iotHubClientHandle->outgoing_head;
+        iotHubClientHandle->outgoing_head = outgoing->next;
+        if (outgoing->callback != NULL)
+            outgoing->callback(IOTHUB_CLIENT_CONFIRMATION_BECAUSE_DESTROY, outgoing->context);
+        IoTHubMessage_Destroy(outgoing->message);
+        free(outgoing);
+    }
+
+    while (iotHubClientHandle->incoming_head != NULL)
+    {
+        INCOMING *incoming = iotHubClientHandle->incoming_head;
+        iotHubClientHandle->incoming_head = incoming->next;
+        IoTHubMessage_Destroy(incoming->message);
+        free(incoming);
+    }
+
+    free(iotHubClientHandle);
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SendEventAsync(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_MESSAGE_HANDLE eventMessageHandle, IOTHUB_CLIENT_EVENT_CONFIRMATION_CALLBACK eventConfirmationCallback, void *userContextCallback)
+{
+    if (iotHubClientHandle == NULL || eventMessageHandle == NULL)
+        return IOTHUB_CLIENT_INVALID_ARG;
+
+    OUTGOING *outgoing = malloc(sizeof(OUTGOING));
+    if (outgoing == NULL)
+        return IOTHUB_CLIENT_ERROR;
+
+    // Like the SDK, keep a clone so the caller owns the handle it passed in.
+    outgoing->message = IoTHubMessage_Clone(eventMessageHandle);
+    if (outgoing->message == NULL)
+    {
+        free(outgoing);
+        return IOTHUB_CLIENT_ERROR;
+    }
+    outgoing->callback = eventConfirmationCallback;
+    outgoing->context = userContextCallback;
+    outgoing->next = NULL;
+
+    // The link sends one message after the other, so a message waits for the previous ones.
+    long long now = stub_clock_now();
+    long long start = iotHubClientHandle->link_free_time > now ? iotHubClientHandle->link_free_time : now;
+    iotHubClientHandle->link_free_time = start + (long long)get_wire_size(outgoing->message) * g_link_cost;
+    outgoing->confirm_time = iotHubClientHandle->link_free_time + g_confirm_latency * 1000;
+
+    if (iotHubClientHandle->outgoing_tail == NULL)
+        iotHubClientHandle->outgoing_head = outgoing;
+    else
+        iotHubClientHandle->outgoing_tail->next = outgoing;
+    iotHubClientHandle->outgoing_tail = outgoing;
+
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetMessageCallback(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, IOTHUB_CLIENT_MESSAGE_CALLBACK_ASYNC messageCallback, void *userContextCallback)
+{
+    if (iotHubClientHandle == NULL)
+        return IOTHUB_CLIENT_INVALID_ARG;
+
+    iotHubClientHandle->message_callback = messageCallback;
+    iotHubClientHandle->message_context = userContextCallback;
+    return IOTHUB_CLIENT_OK;
+}
+
+IOTHUB_CLIENT_RESULT IoTHubClient_LL_SetOption(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle, const char *optionName, const void *value)
+{
+    return iotHubClientHandle == NULL || optionName == NULL ? IOTHUB_CLIENT_INVALID_ARG : IOTHUB_CLIENT_OK;
+}
+
+void IoTHubClient_LL_DoWork(IOTHUB_CLIENT_LL_HANDLE iotHubClientHandle)
+{
+    if (iotHubClientHandle == NULL)
+        return;
+
+    if (g_scheduled_payload != NULL && --g_scheduled_dowork_calls == 0)
+    {
+        stub_iothub_deliver_message(iotHubClientHandle, g_scheduled_payload);
+        free(g_scheduled_payload);
+        g_scheduled_payload = NULL;
+    }
+
+    // Every message takes the same delivery latency, so the queue is in due order too.
+    long long now = stub_clock_now();
+    while (iotHubClientHandle->incoming_head != NULL &&
+           iotHubClientHandle->incoming_head->queued_time + g_delivery_latency * 1000 <= now)
+    {
+        INCOMING *incoming = iotHubClientHandle->incoming_head;
+        iotHubClientHandle->incoming_head = incoming->next;
+        if (iotHubClientHandle->incoming_head == NULL)
+            iotHubClientHandle->incoming_tail = NULL;
+
+        if (iotHubClientHandle->message_callback != NULL)
+            iotHubClientHandle->message_callback(incoming->message, iotHubClientHandle->message_context);
+        IoTHubMessage_Destroy(incoming->message);
+        free(incoming);
+    }
+
+    // Confirmations are delivered in order, so stop at the first message that is not due yet.
+    while (iotHubClientHandle->outgoing_head != NULL &&
+           iotHubClientHandle->outgoing_head->confirm_time <= now)
+    {
+        OUTGOING *outgoing = iotHubClientHandle->outgoing_head;
+        iotHubClientHandle->outgoing_head = outgoing->next;
+        if (iotHubClientHandle->outgoing_head == NULL)
+            iotHubClientHandle->outgoing_tail = NULL;
+
+        g_messages_confirmed++;
+        g_bytes_sent += outgoing->message->size;
+        if (g_confirm_hook != NULL)
+            g_confirm_hook(outgoing->message);
+        if (outgoing->callback != NULL)
+            outgoing->callback(IOTHUB_CLIENT_CONFIRMATION_OK, outgoing->context);
+        IoTHubMessage_Destroy(outgoing->message);
+        free(outgoing);
+    }
+}
+
+void stub_iothub_set_confirm_latency(long long microseconds)
+{
+    g_confirm_latency = microseconds;
+}
+
+void stub_iothub_set_link_cost(long long nanoseconds_per_byte)
+{
+    g_link_cost = nanoseconds_per_byte;
+}
+
+void stub_iothub_set_delivery_latency(long long microseconds)
+{
+    g_delivery_latency = microseconds;
+}
+
+void stub_iothub_set_confirm_hook(STUB_CONFIRM_HOOK hook)
+{
+    g_confirm_hook = hook;
+}
+
+void stub_iothub_deliver_message(IOTHUB_CLIENT_LL_HANDLE handle, const char *payload)
+{
+    INCOMING *incoming = malloc(sizeof(INCOMING));
+    if (incoming == NULL)
+        return;
+
+    incoming->message = IoTHubMessage_CreateFromByteArray((const unsigned char *)payload, strlen(payload));
+    if (incoming->message == NULL)
+    {
+        free(incoming);
+        return;
+    }
+    incoming->queued_time = stub_clock_now();
+    incoming->next = NULL;
+
+    if (handle->incoming_tail == NULL)
+        handle->incoming_head = incoming;
+    else
+        handle->incoming_tail->next = incoming;
+    handle->incoming_tail = incoming;
+}
+
+void stub_iothub_schedule_message(unsigned long dowork_calls, const char *payload)
+{
+    free(g_scheduled_payload);
+    g_scheduled_payload = strdup(payload);
+    g_scheduled_dowork_calls = dowork_calls == 0 ? 1 : dowork_calls;
+}
+
+void stub_iothub_reset_counters(void)
+{
+    g_messages_confirmed = 0;
+    g_bytes_sent = 0;
+}
+
+size_t stub_iothub_messages_confirmed(void)
+{
+    return g_messages_confirmed;
+}
+
+size_t stub_iothub_bytes_sent(void)
+{
+    return g_bytes_sent;
+}
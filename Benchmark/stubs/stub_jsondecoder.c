@@ -0,0 +1,209 @@
+/*
+* Stub of the Azure IoT C SDK serializer JSON decoder, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*
+* Like the SDK decoder, leaves keep their raw JSON token: strings keep their
+* quotes and numbers stay as text. Leaves of nested objects are addressed as
+* "/outer/inner"; arrays are accepted but their elements are not stored.
+*/
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jsondecoder.h"
+
+#define MAX_LEAVES 32
+#define MAX_PATH_LENGTH 128
+
+typedef struct
+{
+    char *path;
+    char *value;
+} LEAF;
+
+struct MULTITREE_HANDLE_DATA_TAG
+{
+    LEAF leaves[MAX_LEAVES];
+    int count;
+};
+
+static const char *skip_space(const char *json)
+{
+    while (isspace((unsigned char)*json))
+        json++;
+    return json;
+}
+
+static const char *skip_string(const char *json)
+{
+    // json points at the opening quote.
+    for (json++; *json != '\0'; json++)
+    {
+        if (*json == '\\')
+        {
+            if (*++json == '\0')
+                return NULL;
+        }
+        else if (*json == '"')
+        {
+            return json + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char *parse_value(const char *json, MULTITREE_HANDLE tree, const char *path, int depth);
+
+static const char *parse_object(const char *json, MULTITREE_HANDLE tree, const char *path, int depth)
+{
+    json = skip_space(json + 1);
+    if (*json == '}')
+        return json + 1;
+
+    while (true)
+    {
+        if (*json != '"')
+            return NULL;
+
+        const char *name = json + 1;
+        const char *name_end = skip_string(json);
+        if (name_end == NULL)
+            return NULL;
+
+        char child_path[MAX_PATH_LENGTH];
+        int length = snprintf(child_path, sizeof(child_path), "%s/%.*s", path, (int)(name_end - 1 - name), name);
+        if (length >= (int)sizeof(child_path))
+            return NULL;
+
+        json = skip_space(name_end);
+        if (*json != ':')
+            return NULL;
+
+        json = parse_value(skip_space(json + 1), tree, child_path, depth + 1);
+        if (json == NULL)
+            return NULL;
+
+        json = skip_space(json);
+        if (*json == '}')
+            return json + 1;
+        if (*json != ',')
+            return NULL;
+        json = skip_space(json + 1);
+    }
+}
+
+static const char *parse_array(const char *json, int depth)
+{
+    json = skip_space(json + 1);
+    if (*json == ']')
+        return json + 1;
+
+    while (true)
+    {
+        json = parse_value(json, NULL, "", depth + 1);
+        if (json == NULL)
+            return NULL;
+
+        json = skip_space(json);
+        if (*json == ']')
+            return json + 1;
+        if (*json != ',')
+            return NULL;
+        json = skip_space(json + 1);
+    }
+}
+
+static const char *parse_value(const char *json, MULTITREE_HANDLE tree, const char *path, int depth)
+{
+    if (depth > 16)
+        return NULL;
+
+    const char *end;
+    if (*json == '{')
+        return parse_object(json, tree, path, depth);
+    if (*json == '[')
+        return parse_array(json, depth);
+
+    if (*json == '"')
+    {
+        end = skip_string(json);
+    }
+    else
+    {
+        end = json;
+        while (*end != '\0' && *end != ',' && *end != '}' && *end != ']' && !isspace((unsigned char)*end))
+            end++;
+        if (end == json)
+            return NULL;
+    }
+
+    if (end == NULL || tree == NULL)
+        return end;
+
+    if (tree->count == MAX_LEAVES)
+        return NULL;
+
+    LEAF *leaf = &tree->leaves[tree->count];
+    leaf->path = strdup(path);
+    leaf->value = strndup(json, end - json);
+    if (leaf->path == NULL || leaf->value == NULL)
+    {
+        free(leaf->path);
+        free(leaf->value);
+        return NULL;
+    }
+    tree->count++;
+    return end;
+}
+
+JSON_DECODER_RESULT JSONDecoder_JSON_To_MultiTree(char *json, MULTITREE_HANDLE *multiTreeHandle)
+{
+    if (json == NULL || multiTreeHandle == NULL)
+        return JSON_DECODER_INVALID_ARG;
+
+    MULTITREE_HANDLE tree = calloc(1, sizeof(struct MULTITREE_HANDLE_DATA_TAG));
+    if (tree == NULL)
+        return JSON_DECODER_ERROR;
+
+    const char *start = skip_space(json);
+    const char *end = *start == '{' ? parse_object(start, tree, "", 0) : NULL;
+    if (end == NULL || *skip_space(end) != '\0')
+    {
+        MultiTree_Destroy(tree);
+        return JSON_DECODER_PARSE_ERROR;
+    }
+
+    *multiTreeHandle = tree;
+    return JSON_DECODER_OK;
+}
+
+MULTITREE_RESULT MultiTree_GetLeafValue(MULTITREE_HANDLE treeHandle, const char *leafPath, const void **destination)
+{
+    if (treeHandle == NULL || leafPath == NULL || destination == NULL)
+        return MULTITREE_INVALID_ARG;
+
+    for (int i = 0; i < treeHandle->count; i++)
+    {
+        if (0 == strcmp(treeHandle->leaves[i].path, leafPath))
+        {
+            *destination = treeHandle->leaves[i].value;
+            return MULTITREE_OK;
+        }
+    }
+    return MULTITREE_CHILD_NOT_FOUND;
+}
+
+void MultiTree_Destroy(MULTITREE_HANDLE treeHandle)
+{
+    if (treeHandle == NULL)
+        return;
+
+    for (int i = 0; i < treeHandle->count; i++)
+    {
+        free(treeHandle->leaves[i].path);
+        free(treeHandle->leaves[i].value);
+    }
+    free(treeHandle);
+}
@@ -0,0 +1,102 @@
+/*
+* Stub of the libmraa API used by the samples, for host benchmarks - Copyright (c) 2016 - Licensed MIT
+*/
+
+#include <stdlib.h>
+#include <mraa.h>
+
+#include "stub_control.h"
+
+#define MAX_AIO_PINS 16
+
+struct _gpio
+{
+    int pin;
+    int value;
+    mraa_gpio_dir_t dir;
+};
+
+struct _aio
+{
+    unsigned int pin;
+};
+
+static int g_aio_values[MAX_AIO_PINS];
+static unsigned long g_gpio_writes = 0;
+static long long g_last_gpio_high_time = 0;
+
+mraa_gpio_context mraa_gpio_init(int pin)
+{
+    mraa_gpio_context dev = calloc(1, sizeof(struct _gpio));
+    if (dev != NULL)
+        dev->pin = pin;
+    return dev;
+}
+
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir)
+{
+    if (dev == NULL)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->dir = dir;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value)
+{
+    if (dev == NULL)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    if (value)
+    {
+        g_last_gpio_high_time = stub_clock_now();
+    }
+
+    dev->value = value;
+    g_gpio_writes++;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev)
+{
+    free(dev);
+    return MRAA_SUCCESS;
+}
+
+mraa_aio_context mraa_aio_init(unsigned int pin)
+{
+    if (pin >= MAX_AIO_PINS)
+        return NULL;
+
+    mraa_aio_context dev = calloc(1, sizeof(struct _aio));
+    if (dev != NULL)
+        dev->pin = pin;
+    return dev;
+}
+
+int mraa_aio_read(mraa_aio_context dev)
+{
+    return dev == NULL ? -1 : g_aio_values[dev->pin];
+}
+
+mraa_result_t mraa_aio_close(mraa_aio_context dev)
+{
+    free(dev);
+    return MRAA_SUCCESS;
+}
+
+void stub_mraa_set_aio_value(unsigned int pin, int value)
+{
+    if (pin < MAX_AIO_PINS)
+        g_aio_values[pin] = value;
+}
+
+unsigned long stub_mraa_gpio_writes(void)
+{
+    return g_gpio_writes;
+}
+
+long long stub_mraa_last_gpio_high_time(void)
+{
+    return g_last_gpio_high_time;
+}
@@ -6,13 +6,27 @@
 // This function is triggered each time a message is revieved in the IoTHub.
 // The message payload is persisted in an Azure Storage Table
 var moment = require('moment');
+var zlib = require('zlib');
 
 module.exports = function (context, iotHubMessage) {
-  context.log('Message received: ' + JSON.stringify(iotHubMessage));
+  // The trigger binding hands the body over as binary, since large payloads
+  // are deflated by the device, see create_message in app/main.c.
+  var properties = context.bindingData.properties || {};
+  var message;
+  try {
+    var body = properties.contentEncoding === 'deflate' ? zlib.inflateSync(iotHubMessage) : iotHubMessage;
+    message = JSON.parse(body.toString());
+  } catch (err) {
+    context.log.error('Failed to decode message: ' + err.message);
+    context.done();
+    return;
+  }
+
+  context.log('Message received: ' + JSON.stringify(message));
   context.bindings.outputTable = {
     "partitionKey": moment.utc().format('YYYYMMDD'),
     "rowKey": moment.utc().format('hhmmss') + process.hrtime()[1] + '',
-    "message": JSON.stringify(iotHubMessage)
+    "message": JSON.stringify(message)
   };
   context.done();
 };
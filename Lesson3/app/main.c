@@ -5,7 +5,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <float.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
 #include <sys/time.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <zlib.h>
 #include <mraa.h>
 
 #include "azure_c_shared_utility/platform.h"
@@ -26,6 +36,77 @@ static int g_last_message_sent_time = 0;
 static bool g_is_message_pending = false;
 static mraa_gpio_context g_context;
 
+#define MAX_POOL_SIZE 8
+#define MAX_SENSORS 64
+#define SENSOR_QUEUE_LENGTH 4
+#define MAX_PENDING_PER_CONNECTION 8
+#define MAX_SENSOR_ID_LENGTH 32
+
+// Readings bound for one connection are batched into a single message that
+// is sent once it is full or its oldest reading is GATEWAY_BATCH_AGE_MS old.
+// A full batch plus its header stays within one 4 KB IoT Hub message unit.
+#define GATEWAY_BATCH_SIZE 3584
+#define GATEWAY_BATCH_AGE_MS 1000
+#define MAX_BATCH_ENTRY_LENGTH 96
+#define GATEWAY_STOP_TIMEOUT_MS 5000
+
+// Payloads at least this long are deflated before they are sent. Below it a
+// telemetry payload saves too few bytes to pay for the "contentEncoding"
+// property that goes with it; see Benchmark/README.md for the measurements.
+#define COMPRESSION_THRESHOLD 160
+#define CONTENT_ENCODING_OVERHEAD (sizeof("contentEncoding") + sizeof("deflate"))
+
+// Payloads are at most a gateway batch, so a 4 KB window loses nothing and
+// keeps the deflate state small enough to be set up once and reused.
+#define DEFLATE_WINDOW_BITS 12
+#define DEFLATE_MEMORY_LEVEL 6
+
+// Readings queued for one downstream sensor. Each sensor is pinned to one
+// connection of the pool so its readings stay in order.
+typedef struct
+{
+    char id[MAX_SENSOR_ID_LENGTH + 1];
+    double readings[SENSOR_QUEUE_LENGTH];
+    int head;
+    int count;
+    int connection;
+} SENSOR;
+
+typedef struct
+{
+    IOTHUB_CLIENT_LL_HANDLE handle;
+    char device_id[257];
+    int pending;
+    char batch[GATEWAY_BATCH_SIZE];
+    int batch_length;
+    int batch_count;
+    long long batch_started_time;
+} GATEWAY_CONNECTION;
+
+typedef struct
+{
+    GATEWAY_CONNECTION *connection;
+    IOTHUB_MESSAGE_HANDLE message;
+    int reading_count;
+    long long sent_time;
+} GATEWAY_SEND_CONTEXT;
+
+typedef struct
+{
+    IOTHUB_MESSAGE_HANDLE message;
+    int message_id;
+    long long sent_time;
+} SEND_CONTEXT;
+
+static GATEWAY_CONNECTION g_pool[MAX_POOL_SIZE];
+static int g_pool_size = 0;
+static SENSOR g_sensors[MAX_SENSORS];
+static int g_sensor_count = 0;
+static int g_first_sensor = 0;
+static volatile sig_atomic_t g_is_gateway_stopping = 0;
+static z_stream g_deflate_stream;
+static bool g_is_deflate_ready = false;
+
 int get_time_in_seconds()
 {
     struct timeval now;
@@ -34,10 +115,23 @@ int get_time_in_seconds()
     return now.tv_sec;
 }
 
+static long long get_monotonic_time_in_milliseconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
 static void send_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *user_context_callback)
 {
+    SEND_CONTEXT *context = (SEND_CONTEXT *)user_context_callback;
+
     if (IOTHUB_CLIENT_CONFIRMATION_OK == result)
     {
+        printf("[Device] Message #%d confirmed in %lld ms\n", context->message_id,
+               get_monotonic_time_in_milliseconds() - context->sent_time);
+
         mraa_gpio_write(g_context, 1);
         usleep(100000);  // light on the LED for 0.1 second
         mraa_gpio_write(g_context, 0);
@@ -49,7 +143,65 @@ static void send_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *user_c
 
     g_is_message_pending = false;
 
-    IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)user_context_callback);
+    IoTHubMessage_Destroy(context->message);
+    free(context);
+}
+
+// Deflate the payload into a new buffer. Returns NULL unless the result,
+// together with the property that marks it, is smaller than the payload.
+static unsigned char *deflate_payload(const char *payload, size_t length, size_t *compressed_length)
+{
+    if (!g_is_deflate_ready)
+    {
+        g_is_deflate_ready = deflateInit2(&g_deflate_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                          DEFLATE_WINDOW_BITS, DEFLATE_MEMORY_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+    if (!g_is_deflate_ready || deflateReset(&g_deflate_stream) != Z_OK)
+        return NULL;
+
+    uLong bound = deflateBound(&g_deflate_stream, length);
+    unsigned char *compressed = malloc(bound);
+    if (compressed == NULL)
+        return NULL;
+
+    g_deflate_stream.next_in = (Bytef *)payload;
+    g_deflate_stream.avail_in = length;
+    g_deflate_stream.next_out = compressed;
+    g_deflate_stream.avail_out = bound;
+
+    if (deflate(&g_deflate_stream, Z_FINISH) != Z_STREAM_END ||
+        g_deflate_stream.total_out + CONTENT_ENCODING_OVERHEAD >= length)
+    {
+        free(compressed);
+        return NULL;
+    }
+
+    *compressed_length = g_deflate_stream.total_out;
+    return compressed;
+}
+
+// Create a message for the payload, deflating it and marking it with a
+// "contentEncoding" property when that makes it smaller.
+static IOTHUB_MESSAGE_HANDLE create_message(const char *payload)
+{
+    size_t length = strlen(payload);
+    size_t compressed_length = 0;
+    unsigned char *compressed = length >= COMPRESSION_THRESHOLD ? deflate_payload(payload, length, &compressed_length) : NULL;
+
+    if (compressed != NULL)
+    {
+        IOTHUB_MESSAGE_HANDLE message_handle = IoTHubMessage_CreateFromByteArray(compressed, compressed_length);
+        free(compressed);
+
+        if (message_handle != NULL &&
+            Map_AddOrUpdate(IoTHubMessage_Properties(message_handle), "contentEncoding", "deflate") == MAP_OK)
+        {
+            return message_handle;
+        }
+        IoTHubMessage_Destroy(message_handle);
+    }
+
+    return IoTHubMessage_CreateFromByteArray((const unsigned char *)payload, length);
 }
 
 static void send_message_and_blink(IOTHUB_CLIENT_LL_HANDLE iot_hub_client_handle, char *device_id)
@@ -57,16 +209,28 @@ static void send_message_and_blink(IOTHUB_CLIENT_LL_HANDLE iot_hub_client_handle
     char buffer[256];
     snprintf(buffer, sizeof(buffer), "{\"deviceId\":\"%s\",\"messageId\":%d}", device_id, g_total_blink_times);
 
-    IOTHUB_MESSAGE_HANDLE message_handle = IoTHubMessage_CreateFromByteArray(buffer, strlen(buffer));
-    if (message_handle == NULL)
+    SEND_CONTEXT *context = malloc(sizeof(SEND_CONTEXT));
+    if (context == NULL)
+    {
+        printf("[Device] ERROR: Failed to allocate memory.\n");
+        return;
+    }
+
+    context->message_id = g_total_blink_times;
+    context->message = create_message(buffer);
+    if (context->message == NULL)
     {
         printf("[Device] ERROR: Unable to create a new IoTHubMessage\n");
+        free(context);
     }
     else
     {
-        if (IoTHubClient_LL_SendEventAsync(iot_hub_client_handle, message_handle, send_callback, message_handle) != IOTHUB_CLIENT_OK)
+        context->sent_time = get_monotonic_time_in_milliseconds();
+        if (IoTHubClient_LL_SendEventAsync(iot_hub_client_handle, context->message, send_callback, context) != IOTHUB_CLIENT_OK)
         {
             printf("[Device] ERROR: Failed to hand over the message to IoTHubClient\n");
+            IoTHubMessage_Destroy(context->message);
+            free(context);
         }
         else
         {
@@ -162,11 +326,372 @@ static bool set_x509_certificate(IOTHUB_CLIENT_LL_HANDLE iot_hub_client_handle,
     return true;
 }
 
+static IOTHUB_CLIENT_LL_HANDLE create_iot_hub_client(char *connection_string, char *device_id)
+{
+    IOTHUB_CLIENT_LL_HANDLE iot_hub_client_handle;
+    if ((iot_hub_client_handle = IoTHubClient_LL_CreateFromConnectionString(connection_string, MQTT_Protocol)) == NULL)
+    {
+        printf("[Device] ERROR: iot_hub_client_handle is NULL!\n");
+        return NULL;
+    }
+
+    if (strstr(connection_string, "x509=true") != NULL)
+    {
+        // Use X.509 certificate authentication.
+        if (!set_x509_certificate(iot_hub_client_handle, device_id))
+        {
+            IoTHubClient_LL_Destroy(iot_hub_client_handle);
+            return NULL;
+        }
+    }
+
+    if (IoTHubClient_LL_SetOption(iot_hub_client_handle, "TrustedCerts", certificates) != IOTHUB_CLIENT_OK)
+    {
+        printf("[Device] ERROR: Failed to set TrustedCerts option\n");
+    }
+
+    return iot_hub_client_handle;
+}
+
+static void gateway_send_callback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *user_context_callback)
+{
+    GATEWAY_SEND_CONTEXT *context = (GATEWAY_SEND_CONTEXT *)user_context_callback;
+
+    if (IOTHUB_CLIENT_CONFIRMATION_OK == result)
+    {
+        printf("[Gateway] Batch of %d reading(s) from %s confirmed in %lld ms\n", context->reading_count,
+               context->connection->device_id, get_monotonic_time_in_milliseconds() - context->sent_time);
+    }
+    else
+    {
+        printf("[Gateway] ERROR: Failed to send message to Azure IoT Hub\n");
+    }
+
+    context->connection->pending--;
+    IoTHubMessage_Destroy(context->message);
+    free(context);
+}
+
+static SENSOR *find_or_add_sensor(const char *id)
+{
+    for (int i = 0; i < g_sensor_count; i++)
+    {
+        if (0 == strcmp(g_sensors[i].id, id))
+            return &g_sensors[i];
+    }
+
+    if (g_sensor_count == MAX_SENSORS)
+        return NULL;
+
+    SENSOR *sensor = &g_sensors[g_sensor_count];
+    memset(sensor, 0, sizeof(SENSOR));
+    snprintf(sensor->id, sizeof(sensor->id), "%s", id);
+    sensor->connection = g_sensor_count % g_pool_size;
+    g_sensor_count++;
+
+    printf("[Gateway] Sensor %s is mapped to device %s\n", sensor->id, g_pool[sensor->connection].device_id);
+    return sensor;
+}
+
+// Sensor ids are copied into JSON strings, so only a safe character set is accepted.
+static bool is_valid_sensor_id(const char *id)
+{
+    size_t length = strlen(id);
+    if (length == 0 || length > MAX_SENSOR_ID_LENGTH)
+        return false;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!isalnum((unsigned char)id[i]) && strchr("-_.:", id[i]) == NULL)
+            return false;
+    }
+    return true;
+}
+
+// A datagram is "<sensor id> <numeric reading>", e.g. "temp-01 23.5".
+static void enqueue_reading(char *datagram)
+{
+    char *reading = strchr(datagram, ' ');
+    if (reading == NULL)
+        return;
+    *reading++ = '\0';
+
+    if (!is_valid_sensor_id(datagram))
+    {
+        printf("[Gateway] ERROR: Invalid sensor id in datagram\n");
+        return;
+    }
+
+    char *end = NULL;
+    errno = 0;
+    double value = strtod(reading, &end);
+    while (isspace((unsigned char)*end))
+        end++;
+    if (end == reading || *end != '\0' || errno != 0 || !isfinite(value))
+    {
+        printf("[Gateway] ERROR: Invalid reading from sensor %s\n", datagram);
+        return;
+    }
+
+    SENSOR *sensor = find_or_add_sensor(datagram);
+    if (sensor == NULL)
+    {
+        printf("[Gateway] ERROR: No room for more than %d sensors\n", MAX_SENSORS);
+        return;
+    }
+
+    // A full queue drops its oldest reading so a chatty sensor cannot hold up the others.
+    if (sensor->count == SENSOR_QUEUE_LENGTH)
+    {
+        sensor->head = (sensor->head + 1) % SENSOR_QUEUE_LENGTH;
+        sensor->count--;
+    }
+
+    sensor->readings[(sensor->head + sensor->count) % SENSOR_QUEUE_LENGTH] = value;
+    sensor->count++;
+}
+
+// Move the sensor's oldest reading into its connection's batch, unless the
+// batch has no room left for it.
+static bool batch_reading(SENSOR *sensor)
+{
+    GATEWAY_CONNECTION *connection = &g_pool[sensor->connection];
+    char entry[MAX_BATCH_ENTRY_LENGTH];
+    int length = snprintf(entry, sizeof(entry), "%s{\"deviceId\":\"%s\",\"reading\":%.*g}",
+                          connection->batch_count == 0 ? "" : ",", sensor->id, DBL_DIG, sensor->readings[sensor->head]);
+
+    if (length >= (int)sizeof(entry) || connection->batch_length + length >= GATEWAY_BATCH_SIZE)
+        return false;
+
+    if (connection->batch_count == 0)
+        connection->batch_started_time = get_monotonic_time_in_milliseconds();
+
+    memcpy(connection->batch + connection->batch_length, entry, length + 1);
+    connection->batch_length += length;
+    connection->batch_count++;
+
+    sensor->head = (sensor->head + 1) % SENSOR_QUEUE_LENGTH;
+    sensor->count--;
+    return true;
+}
+
+static bool send_batch(GATEWAY_CONNECTION *connection)
+{
+    if (connection->pending >= MAX_PENDING_PER_CONNECTION)
+        return false;
+
+    char buffer[GATEWAY_BATCH_SIZE + 512];
+    snprintf(buffer, sizeof(buffer), "{\"gatewayId\":\"%s\",\"readings\":[%s]}", connection->device_id, connection->batch);
+
+    GATEWAY_SEND_CONTEXT *context = malloc(sizeof(GATEWAY_SEND_CONTEXT));
+    if (context == NULL)
+        return false;
+
+    context->connection = connection;
+    context->reading_count = connection->batch_count;
+    context->sent_time = get_monotonic_time_in_milliseconds();
+    context->message = create_message(buffer);
+    if (context->message == NULL)
+    {
+        printf("[Gateway] ERROR: Unable to create a new IoTHubMessage\n");
+        free(context);
+        return false;
+    }
+
+    if (IoTHubClient_LL_SendEventAsync(connection->handle, context->message, gateway_send_callback, context) != IOTHUB_CLIENT_OK)
+    {
+        printf("[Gateway] ERROR: Failed to hand over the message to IoTHubClient\n");
+        IoTHubMessage_Destroy(context->message);
+        free(context);
+        return false;
+    }
+
+    connection->pending++;
+    connection->batch_length = 0;
+    connection->batch_count = 0;
+    connection->batch[0] = '\0';
+    return true;
+}
+
+// Send every batch that is full or old enough, or every non-empty batch when forced.
+static void send_due_batches(bool force)
+{
+    long long now = get_monotonic_time_in_milliseconds();
+
+    for (int i = 0; i < g_pool_size; i++)
+    {
+        GATEWAY_CONNECTION *connection = &g_pool[i];
+        if (connection->batch_count > 0 &&
+            (force ||
+             connection->batch_length > GATEWAY_BATCH_SIZE - MAX_BATCH_ENTRY_LENGTH ||
+             connection->batch_started_time + GATEWAY_BATCH_AGE_MS <= now))
+        {
+            send_batch(connection);
+        }
+    }
+}
+
+static void stop_gateway(int signal_number)
+{
+    g_is_gateway_stopping = 1;
+}
+
+static int open_gateway_socket(int port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        printf("[Gateway] ERROR: Failed to create socket\n");
+        return -1;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+        fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        printf("[Gateway] ERROR: Failed to listen on port %d\n", port);
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+// One gateway round: take in every pending datagram, batch at most one reading
+// per sensor, send the batches that are due, then let each connection of the
+// pool do its work. The sensor that goes first rotates every round so that,
+// when batches fill up, the room left is not always taken by the same sensors.
+static void poll_gateway(int sock)
+{
+    char datagram[256];
+    ssize_t length;
+    while ((length = recv(sock, datagram, sizeof(datagram) - 1, 0)) > 0)
+    {
+        datagram[length] = '\0';
+        enqueue_reading(datagram);
+    }
+
+    for (int i = 0; i < g_sensor_count; i++)
+    {
+        SENSOR *sensor = &g_sensors[(g_first_sensor + i) % g_sensor_count];
+        if (sensor->count > 0)
+            batch_reading(sensor);
+    }
+    if (g_sensor_count > 0)
+        g_first_sensor = (g_first_sensor + 1) % g_sensor_count;
+
+    send_due_batches(false);
+
+    for (int i = 0; i < g_pool_size; i++)
+    {
+        IoTHubClient_LL_DoWork(g_pool[i].handle);
+    }
+}
+
+// Forward readings received on a local UDP port until SIGINT or SIGTERM.
+static bool run_gateway(int port)
+{
+    int sock = open_gateway_socket(port);
+    if (sock < 0)
+        return false;
+
+    signal(SIGINT, stop_gateway);
+    signal(SIGTERM, stop_gateway);
+
+    printf("[Gateway] Listening for sensor readings on UDP port %d with %d connection(s)\n", port, g_pool_size);
+
+    while (!g_is_gateway_stopping)
+    {
+        poll_gateway(sock);
+        usleep(10000);  // sleep for 0.01 second
+    }
+
+    // Give partly filled and in-flight batches some time to go out before the pool is destroyed.
+    long long deadline = get_monotonic_time_in_milliseconds() + GATEWAY_STOP_TIMEOUT_MS;
+    bool is_sending = true;
+    while (is_sending && get_monotonic_time_in_milliseconds() < deadline)
+    {
+        send_due_batches(true);
+
+        is_sending = false;
+        for (int i = 0; i < g_pool_size; i++)
+        {
+            IoTHubClient_LL_DoWork(g_pool[i].handle);
+            is_sending = is_sending || g_pool[i].pending > 0 || g_pool[i].batch_count > 0;
+        }
+        usleep(10000);  // sleep for 0.01 second
+    }
+
+    close(sock);
+    return true;
+}
+
 int main(int argc, char *argv[])
 {
     printf("[Device] Starting the IoT Hub sample...\n");
 
-    // argv[1] is the IoT Hub connection string.
+    // argv[1] is the IoT Hub connection string. In gateway mode the
+    // arguments are "--gateway <port>" followed by one connection string
+    // per connection in the pool.
+    if (argc >= 2 && 0 == strcmp(argv[1], "--gateway"))
+    {
+        char *end = NULL;
+        long port = argc >= 3 ? strtol(argv[2], &end, 10) : 0;
+        bool result = false;
+
+        if (argc < 4 || end == argv[2] || *end != '\0' || port < 1 || port > 65535)
+        {
+            printf("[Gateway] ERROR: Usage: --gateway <UDP port 1-65535> <connection string> [<connection string> ...]\n");
+            return 1;
+        }
+
+        if (argc - 3 > MAX_POOL_SIZE)
+        {
+            printf("[Gateway] ERROR: At most %d connection strings are supported\n", MAX_POOL_SIZE);
+            return 1;
+        }
+
+        if (platform_init() != 0)
+        {
+            printf("[Device] ERROR: Failed to initialize the platform.\n");
+            return 1;
+        }
+
+        for (int i = 3; i < argc; i++)
+        {
+            GATEWAY_CONNECTION *connection = &g_pool[g_pool_size];
+            char *device_id_src = get_device_id(argv[i]);
+            if (device_id_src == NULL)
+            {
+                printf("[Device] ERROR: Cannot parse device id from IoT device connection string\n");
+                break;
+            }
+            snprintf(connection->device_id, sizeof(connection->device_id), "%s", device_id_src);
+            free(device_id_src);
+
+            if ((connection->handle = create_iot_hub_client(argv[i], connection->device_id)) == NULL)
+                break;
+            g_pool_size++;
+        }
+
+        if (g_pool_size == argc - 3)
+        {
+            result = run_gateway((int)port);
+        }
+
+        for (int i = 0; i < g_pool_size; i++)
+        {
+            IoTHubClient_LL_Destroy(g_pool[i].handle);
+        }
+        platform_deinit();
+        return result ? 0 : 1;
+    }
+
     if (argc < 2)
     {
         printf("[Device] ERROR: IoT device connection string should be passed as a parameter\n");
@@ -194,26 +719,14 @@ int main(int argc, char *argv[])
     else
     {
         IOTHUB_CLIENT_LL_HANDLE iot_hub_client_handle;
-        if ((iot_hub_client_handle = IoTHubClient_LL_CreateFromConnectionString(argv[1], MQTT_Protocol)) == NULL)
+        if ((iot_hub_client_handle = create_iot_hub_client(argv[1], device_id)) == NULL)
         {
-            printf("[Device] ERROR: iot_hub_client_handle is NULL!\n");
+            printf("[Device] ERROR: Failed to create the IoT Hub client\n");
+            platform_deinit();
+            return 1;
         }
         else
         {
-            if (strstr(argv[1], "x509=true") != NULL)
-            {
-                // Use X.509 certificate authentication.
-                if (!set_x509_certificate(iot_hub_client_handle, device_id))
-                {
-                    return 1;
-                }
-            }
-
-            if (IoTHubClient_LL_SetOption(iot_hub_client_handle, "TrustedCerts", certificates) != IOTHUB_CLIENT_OK)
-            {
-                printf("[Device] ERROR: Failed to set TrustedCerts option\n");
-            }
-
             while ((g_total_blink_times <= MAX_BLINK_TIMES) || g_is_message_pending)
             {
                 if ((g_last_message_sent_time + 2 <= get_time_in_seconds()) && !g_is_message_pending)
@@ -3,6 +3,7 @@
 */
 'use strict';
 
+var zlib = require('zlib');
 var EventHubClient = require('azure-event-hubs').Client;
 var iotHubClient;
 
@@ -16,7 +17,17 @@ var readIoTHub = function (config) {
     console.log(err.message);
   };
   var printMessage = function (message) {
-    console.log('[IoT Hub] Received message: ' + JSON.stringify(message.body) + '\n');
+    var body = message.body;
+    // Large payloads are deflated by the device, see create_message in app/main.c.
+    if (message.applicationProperties && message.applicationProperties.contentEncoding === 'deflate') {
+      try {
+        body = JSON.parse(zlib.inflateSync(body).toString());
+      } catch (err) {
+        console.error('[IoT Hub] Failed to decode message: ' + err.message + '\n');
+        return;
+      }
+    }
+    console.log('[IoT Hub] Received message: ' + JSON.stringify(body) + '\n');
   };
 
   // Only receive messages sent to IoT Hub after this time.
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <limits.h>
 #include <mraa.h>
 
 #include "azure_c_shared_utility/platform.h"
@@ -20,8 +22,29 @@
 
 static const int LED_PIN = 13;
 
+#define MAX_RULES 8
+
+typedef enum
+{
+    RULE_ABOVE,
+    RULE_BELOW
+} RULE_OP;
+
+// A rule fires once when `window` consecutive samples of the analog pin are
+// above/below `threshold`, and is re-armed by the next sample that is not.
+typedef struct
+{
+    mraa_aio_context aio;
+    RULE_OP op;
+    int threshold;
+    int window;
+    int hits;
+} RULE;
+
 static bool is_last_message_received = false;
 static mraa_gpio_context g_context;
+static RULE g_rules[MAX_RULES];
+static int g_rule_count = 0;
 
 static void blink_led()
 {
@@ -30,6 +53,125 @@ static void blink_led()
     mraa_gpio_write(g_context, 0);
 }
 
+static void clear_rules()
+{
+    for (int i = 0; i < g_rule_count; i++)
+    {
+        mraa_aio_close(g_rules[i].aio);
+    }
+    g_rule_count = 0;
+}
+
+// MultiTree leaves hold the raw JSON token, so a quoted value such as "512"
+// keeps its quotes and is rejected here rather than read as 0.
+static bool parse_int(const void *token, int *result)
+{
+    const char *text = (const char *)token;
+    char *end = NULL;
+
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || value < INT_MIN || value > INT_MAX)
+        return false;
+
+    *result = (int)value;
+    return true;
+}
+
+static void add_rule(MULTITREE_HANDLE tree)
+{
+    const void *token = NULL;
+    int pin;
+    int threshold;
+    int window = 1;
+    RULE_OP op;
+
+    if (g_rule_count == MAX_RULES)
+    {
+        printf("[Device] ERROR: No room for more than %d rules\n", MAX_RULES);
+        return;
+    }
+
+    if (MULTITREE_OK != MultiTree_GetLeafValue(tree, "/pin", &token) || !parse_int(token, &pin) || pin < 0)
+    {
+        printf("[Device] ERROR: Rule needs a non-negative integer pin\n");
+        return;
+    }
+
+    const void *below_token = NULL;
+    bool has_above = MULTITREE_OK == MultiTree_GetLeafValue(tree, "/above", &token);
+    bool has_below = MULTITREE_OK == MultiTree_GetLeafValue(tree, "/below", &below_token);
+    if (has_above && has_below)
+    {
+        printf("[Device] ERROR: Rule must have either above or below, not both\n");
+        return;
+    }
+    else if (has_above)
+    {
+        op = RULE_ABOVE;
+    }
+    else if (has_below)
+    {
+        op = RULE_BELOW;
+        token = below_token;
+    }
+    else
+    {
+        printf("[Device] ERROR: Rule has no threshold\n");
+        return;
+    }
+
+    if (!parse_int(token, &threshold))
+    {
+        printf("[Device] ERROR: Rule threshold must be an integer\n");
+        return;
+    }
+
+    if (MULTITREE_OK == MultiTree_GetLeafValue(tree, "/window", &token) && (!parse_int(token, &window) || window < 1))
+    {
+        printf("[Device] ERROR: Rule window must be a positive integer\n");
+        return;
+    }
+
+    mraa_aio_context aio = mraa_aio_init(pin);
+    if (aio == NULL)
+    {
+        printf("[Device] ERROR: Failed to initialize analog pin %d\n", pin);
+        return;
+    }
+
+    RULE *rule = &g_rules[g_rule_count++];
+    rule->aio = aio;
+    rule->op = op;
+    rule->threshold = threshold;
+    rule->window = window;
+    rule->hits = 0;
+}
+
+// Sample every rule's pin once and blink locally for each rule that fires,
+// so the device reacts without waiting for a cloud-to-device message.
+static void evaluate_rules()
+{
+    for (int i = 0; i < g_rule_count; i++)
+    {
+        RULE *rule = &g_rules[i];
+        int value = mraa_aio_read(rule->aio);
+        if (value < 0)
+            continue;
+
+        bool matched = rule->op == RULE_ABOVE ? value > rule->threshold : value < rule->threshold;
+        if (!matched)
+        {
+            rule->hits = 0;
+        }
+        else if (rule->hits < rule->window && ++rule->hits == rule->window)
+        {
+            printf("[Device] Rule #%d fired with value %d\n", i, value);
+            blink_led();
+        }
+    }
+}
+
 IOTHUBMESSAGE_DISPOSITION_RESULT receive_message_callback(IOTHUB_MESSAGE_HANDLE message, void *user_context_callback)
 {
     const unsigned char *buffer = NULL;
@@ -65,6 +207,14 @@ IOTHUBMESSAGE_DISPOSITION_RESULT receive_message_callback(IOTHUB_MESSAGE_HANDLE
             {
                 is_last_message_received = true;
             }
+            else if (0 == strcmp((const char *)value, "\"rule\""))
+            {
+                add_rule(tree);
+            }
+            else if (0 == strcmp((const char *)value, "\"clear-rules\""))
+            {
+                clear_rules();
+            }
         }
     }
 
@@ -215,10 +365,12 @@ int main(int argc, char *argv[])
 
             while (!is_last_message_received)
             {
+                evaluate_rules();
                 IoTHubClient_LL_DoWork(iot_hub_client_handle);
                 usleep(100000);  // sleep for 0.1 second
             }
 
+            clear_rules();
             IoTHubClient_LL_Destroy(iot_hub_client_handle);
         }
         platform_deinit();